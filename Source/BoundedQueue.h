@@ -0,0 +1,79 @@
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+
+#include <deque>
+#include <utility>
+#include <mutex>
+#include <condition_variable>
+
+
+// A BoundedQueue is a first-in-first-out queue for passing items between threads, which holds at most a given number of items.
+// Pushing to a full queue blocks until an item was popped, popping from an empty queue blocks until an item was pushed.
+// After the queue was closed, no more items can be pushed, and popping fails as soon as the queue is empty.
+//
+template <typename Item>
+class BoundedQueue
+{
+	public:
+		explicit BoundedQueue( int _capacity ) : m_capacity( _capacity ) {}
+
+		// Push an item to the back of the queue. Returns false, if the queue was closed.
+		bool push( Item _item )
+		{
+			std::unique_lock<std::mutex> lock( m_mutex );
+
+			m_notFull.wait( lock, [this]() { return m_closed || (static_cast<int>( m_items.size() ) < m_capacity); } );
+
+			if( m_closed )
+				return false;
+
+			m_items.push_back( std::move( _item ) );
+			m_notEmpty.notify_one();
+
+			return true;
+		}
+
+		// Pop an item from the front of the queue. Returns false, if the queue was closed and is empty.
+		bool pop( Item &_item )
+		{
+			std::unique_lock<std::mutex> lock( m_mutex );
+
+			m_notEmpty.wait( lock, [this]() { return m_closed || !m_items.empty(); } );
+
+			if( m_items.empty() )
+				return false;
+
+			_item = std::move( m_items.front() );
+			m_items.pop_front();
+			m_notFull.notify_one();
+
+			return true;
+		}
+
+		// Close the queue. Items that were pushed before can still be popped.
+		void close()
+		{
+			std::lock_guard<std::mutex> lock( m_mutex );
+
+			m_closed = true;
+			m_notFull .notify_all();
+			m_notEmpty.notify_all();
+		}
+
+	private:
+		// The stored items and the maximum number of stored items
+		std::deque<Item> m_items;
+		int              m_capacity;
+
+		// Whether the queue was closed
+		bool m_closed = false;
+
+		// The synchronization of the pushing and popping threads
+		std::mutex              m_mutex;
+		std::condition_variable m_notFull;
+		std::condition_variable m_notEmpty;
+};
+
+
+#endif // BOUNDEDQUEUE_H
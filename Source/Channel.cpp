@@ -0,0 +1,119 @@
+#include "Channel.h"
+
+#include <iostream>
+
+#ifndef _WIN32
+	#include <unistd.h>
+	#include <sys/socket.h>
+#endif
+
+
+// Do not raise a signal when sending to a channel whose other end was closed, but let sending fail instead
+#ifdef MSG_NOSIGNAL
+	static const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+	static const int SEND_FLAGS = 0;
+#endif
+
+
+Channel::~Channel()
+{
+	close();
+}
+
+
+// Create the channel. This has to be done before the processes are forked.
+bool Channel::create()
+{
+#ifndef _WIN32
+	if( socketpair( AF_UNIX, SOCK_STREAM, 0, m_sockets ) != 0 )
+	{
+		std::cerr << "Could not create channel." << std::endl;
+		return false;
+	}
+
+	return true;
+#else
+	std::cerr << "Channels are not supported on this platform." << std::endl;
+	return false;
+#endif
+}
+
+
+// Use the given end (0 or 1) of the channel in the current process, and close the other end
+void Channel::useEnd( int _end )
+{
+#ifndef _WIN32
+	m_end = _end;
+
+	if( m_sockets[ 1 - m_end ] >= 0 )
+	{
+		::close( m_sockets[ 1 - m_end ] );
+		m_sockets[ 1 - m_end ] = -1;
+	}
+#endif
+}
+
+
+// Close both ends of the channel in the current process
+void Channel::close()
+{
+#ifndef _WIN32
+	for( int end = 0; end < 2; ++end )
+	{
+		if( m_sockets[ end ] >= 0 )
+		{
+			::close( m_sockets[ end ] );
+			m_sockets[ end ] = -1;
+		}
+	}
+#endif
+}
+
+
+// Send a message of the given size
+bool Channel::send( const void *_data, size_t _size )
+{
+#ifndef _WIN32
+	const char *data = static_cast<const char*>( _data );
+
+	// A large message may be sent in several parts
+	while( _size > 0 )
+	{
+		ssize_t sentSize = ::send( m_sockets[ m_end ], data, _size, SEND_FLAGS );
+		if( sentSize <= 0 )
+			return false;
+
+		data  += sentSize;
+		_size -= sentSize;
+	}
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+// Receive a message of the given size. Blocks until the whole message has arrived.
+bool Channel::receive( void *_data, size_t _size )
+{
+#ifndef _WIN32
+	char *data = static_cast<char*>( _data );
+
+	// A large message may arrive in several parts
+	while( _size > 0 )
+	{
+		ssize_t receivedSize = ::recv( m_sockets[ m_end ], data, _size, 0 );
+		if( receivedSize <= 0 )
+			return false;
+
+		data  += receivedSize;
+		_size -= receivedSize;
+	}
+
+	return true;
+#else
+	return false;
+#endif
+}
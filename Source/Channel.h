@@ -0,0 +1,50 @@
+#ifndef CHANNEL_H
+#define CHANNEL_H
+
+
+#include <cstddef>
+
+
+// A Channel is a bidirectional, blocking message channel between two processes on the same machine, based on a local socket pair.
+// It stands in for the interconnect between the nodes of a cluster. The channel is created before the processes are forked,
+// and afterwards each of the two processes uses one of the two ends of the channel.
+// Channels are only available on POSIX systems. On other systems, create() fails.
+//
+class Channel
+{
+	public:
+		Channel() {}
+		~Channel();
+
+		// Create the channel. This has to be done before the processes are forked.
+		bool create();
+
+		// Use the given end (0 or 1) of the channel in the current process, and close the other end
+		void useEnd( int _end );
+
+		// Close both ends of the channel in the current process
+		void close();
+
+		// Send/receive a message of the given size. Receiving blocks until the whole message has arrived.
+		bool send   ( const void *_data, size_t _size );
+		bool receive(       void *_data, size_t _size );
+
+		// Send/receive a single value
+		template <typename Value> bool sendValue   ( const Value &_value ) { return send   ( &_value, sizeof( Value ) ); }
+		template <typename Value> bool receiveValue(       Value &_value ) { return receive( &_value, sizeof( Value ) ); }
+
+	private:
+		// Channels can not be copied, since they own their sockets
+		Channel( const Channel & );
+		Channel &operator=( const Channel & );
+
+	private:
+		// The sockets of both ends of the channel (-1, if closed)
+		int m_sockets[2] = { -1, -1 };
+
+		// The end of the channel that is used by the current process
+		int m_end = 0;
+};
+
+
+#endif // CHANNEL_H
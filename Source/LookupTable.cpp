@@ -3,6 +3,21 @@
 #include <iostream>
 #include <fstream>
 
+#if defined( _MSC_VER )
+	#include <xmmintrin.h>
+	#define PREFETCH( _address ) _mm_prefetch( reinterpret_cast<const char*>( _address ), _MM_HINT_T0 )
+#else
+	#define PREFETCH( _address ) __builtin_prefetch( _address )
+#endif
+
+
+// The number of entries that are prefetched ahead of the current access in getEntries()
+static const int PREFETCH_DISTANCE = 16;
+
+
+// Out-of-class definition, needed when MAX_BATCH_SIZE is bound to a reference (e.g. by std::min)
+const int LookupTable::MAX_BATCH_SIZE;
+
 
 // Read a lookup table binary file. The file is 2^26 bits = 8 MiB in size.
 bool LookupTable::readFile( const std::string &_filename )
@@ -89,21 +104,30 @@ bool LookupTable::writeFile( const std::string &_filename ) const
 // Get the stored lookup table entry. The value of the middle voxel is ignored.
 LookupTable::Entry LookupTable::getEntry( const VolumeData::Voxel _neighborhood[27] ) const
 {
-	// Get the index in the lookup table
-	int entryIdx = (
-		(_neighborhood[ 0] <<  0) | (_neighborhood[ 1] <<  1) | (_neighborhood[ 2] <<  2) |
-		(_neighborhood[ 3] <<  3) | (_neighborhood[ 4] <<  4) | (_neighborhood[ 5] <<  5) |
-		(_neighborhood[ 6] <<  6) | (_neighborhood[ 7] <<  7) | (_neighborhood[ 8] <<  8) |
-	
-		(_neighborhood[ 9] <<  9) | (_neighborhood[10] << 10) | (_neighborhood[11] << 11) |
-		(_neighborhood[12] << 12) |      /* ignored */          (_neighborhood[14] << 13) |
-		(_neighborhood[15] << 14) | (_neighborhood[16] << 15) | (_neighborhood[17] << 16) |
-
-		(_neighborhood[18] << 17) | (_neighborhood[19] << 18) | (_neighborhood[20] << 19) |
-		(_neighborhood[21] << 20) | (_neighborhood[22] << 21) | (_neighborhood[23] << 22) |
-		(_neighborhood[24] << 23) | (_neighborhood[25] << 24) | (_neighborhood[26] << 25)
-	);
-
-	// Return the lookup table entry
-	return m_entries[ entryIdx ];
+	return m_entries[ getEntryIdx( _neighborhood ) ];
+}
+
+
+// Get the stored lookup table entries for a batch of up to MAX_BATCH_SIZE precomputed indices.
+// Bit i of the returned mask is set, if the entry for _entryIndices[i] is set.
+LookupTable::EntryMask LookupTable::getEntries( const Index *_entryIndices, int _numEntries ) const
+{
+	const Entry *entries = m_entries.data();
+
+	// Prefetch the first entries of the batch
+	for( int i = 0; (i < PREFETCH_DISTANCE) && (i < _numEntries); ++i )
+		PREFETCH( entries + _entryIndices[i] );
+
+	EntryMask entryMask = 0;
+
+	for( int i = 0; i < _numEntries; ++i )
+	{
+		// Prefetch the entry that is needed PREFETCH_DISTANCE accesses later, while the current one is read
+		if( i + PREFETCH_DISTANCE < _numEntries )
+			PREFETCH( entries + _entryIndices[ i + PREFETCH_DISTANCE ] );
+
+		entryMask |= static_cast<EntryMask>( entries[ _entryIndices[i] ] ) << i;
+	}
+
+	return entryMask;
 }
@@ -4,6 +4,7 @@
 
 #include <string>
 #include <vector>
+#include <cstdint>
 
 #include "VolumeData.h"
 
@@ -19,13 +20,31 @@ class LookupTable
 	public:
 		typedef unsigned char Entry;
 
+		// The index of a lookup table entry, one bit for each of the 26 neighbors of the middle voxel
+		typedef int Index;
+
+		// A bitmask of lookup table entries, one bit for each entry of a batch
+		typedef std::uint64_t EntryMask;
+
+		// The maximum number of entries that can be queried at once with getEntries()
+		static const int MAX_BATCH_SIZE = 64;
+
 	public:
 		// Read/write a lookup table binary file
 		bool readFile ( const std::string &_filename );
 		bool writeFile( const std::string &_filename ) const;
 
+		// Get the index of the lookup table entry for the given neighborhood. The value of the middle voxel is ignored.
+		static Index getEntryIdx( const VolumeData::Voxel _neighborhood[27] );
+
 		// Get the stored lookup table entry. The value of the middle voxel is ignored.
 		Entry getEntry( const VolumeData::Voxel _neighborhood[27] ) const;
+		Entry getEntry( Index _entryIdx ) const { return m_entries[ _entryIdx ]; }
+
+		// Get the stored lookup table entries for a batch of up to MAX_BATCH_SIZE precomputed indices.
+		// Bit i of the returned mask is set, if the entry for _entryIndices[i] is set.
+		// The accesses are prefetched ahead, so that their memory latencies overlap.
+		EntryMask getEntries( const Index *_entryIndices, int _numEntries ) const;
 
 	private:
 		// The stored lookup table entries
@@ -33,4 +52,24 @@ class LookupTable
 };
 
 
+// Get the index of the lookup table entry for the given neighborhood. The value of the middle voxel is ignored.
+// This is inlined, since it is called for every front voxel of every direction subcycle.
+inline LookupTable::Index LookupTable::getEntryIdx( const VolumeData::Voxel _neighborhood[27] )
+{
+	return (
+		(_neighborhood[ 0] <<  0) | (_neighborhood[ 1] <<  1) | (_neighborhood[ 2] <<  2) |
+		(_neighborhood[ 3] <<  3) | (_neighborhood[ 4] <<  4) | (_neighborhood[ 5] <<  5) |
+		(_neighborhood[ 6] <<  6) | (_neighborhood[ 7] <<  7) | (_neighborhood[ 8] <<  8) |
+	
+		(_neighborhood[ 9] <<  9) | (_neighborhood[10] << 10) | (_neighborhood[11] << 11) |
+		(_neighborhood[12] << 12) |      /* ignored */          (_neighborhood[14] << 13) |
+		(_neighborhood[15] << 14) | (_neighborhood[16] << 15) | (_neighborhood[17] << 16) |
+
+		(_neighborhood[18] << 17) | (_neighborhood[19] << 18) | (_neighborhood[20] << 19) |
+		(_neighborhood[21] << 20) | (_neighborhood[22] << 21) | (_neighborhood[23] << 22) |
+		(_neighborhood[24] << 23) | (_neighborhood[25] << 24) | (_neighborhood[26] << 25)
+	);
+}
+
+
 #endif // LOOKUPTABLE_H
@@ -0,0 +1,13 @@
+#include "LookupTable2D.h"
+
+
+// Create the lookup table from the middle slice entries of the given (3D) lookup table
+void LookupTable2D::create( const LookupTable &_lookupTable )
+{
+	for( int entryIdx = 0; entryIdx < 256; ++entryIdx )
+	{
+		// The 8 neighbors of the middle pixel are the neighborhood voxels 9 to 17 (without the middle voxel 13),
+		// which are stored in the bits 9 to 16 of the (3D) lookup table index. All other neighborhood voxels are 0.
+		m_entries[ entryIdx ] = _lookupTable.getEntry( entryIdx << 9 );
+	}
+}
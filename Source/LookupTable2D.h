@@ -0,0 +1,36 @@
+#ifndef LOOKUPTABLE2D_H
+#define LOOKUPTABLE2D_H
+
+
+#include "LookupTable.h"
+
+
+// A LookupTable2D is a lookup table of 2^8 boolean entries, one for each combination
+// of a local 3x3 neighborhood of digital pixels (either set to 0 or 1), where
+// the middle pixel always is 1 (thus 2^8 and not 2^9).
+// It is derived from a (3D) LookupTable: a pixel of a 2D image has the same neighborhood as a voxel
+// of a volume with a size of 1 in Z, i.e. its 3x3 neighborhood is the middle slice of a 3x3x3 neighborhood
+// whose other two slices are 0. The 256 entries (256 bytes) easily fit into the L1 cache.
+//
+class LookupTable2D
+{
+	public:
+		typedef LookupTable::Entry Entry;
+
+		// The index of a lookup table entry, one bit for each of the 8 neighbors of the middle pixel
+		typedef unsigned char Index;
+
+	public:
+		// Create the lookup table from the middle slice entries of the given (3D) lookup table
+		void create( const LookupTable &_lookupTable );
+
+		// Get the stored lookup table entry
+		Entry getEntry( Index _entryIdx ) const { return m_entries[ _entryIdx ]; }
+
+	private:
+		// The stored lookup table entries
+		Entry m_entries[256];
+};
+
+
+#endif // LOOKUPTABLE2D_H
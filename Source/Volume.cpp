@@ -2,6 +2,16 @@
 
 #include <tuple>
 #include <deque>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+#ifndef _WIN32
+	#include <unistd.h>
+	#include <sys/types.h>
+	#include <sys/wait.h>
+#endif
 
 #include <vtkImageReader.h>
 #include <vtkImageWriter.h>
@@ -15,12 +25,29 @@
 #include <vtkVolume.h>
 #include <vtkVolumeProperty.h>
 
+#include "LookupTable2D.h"
+#include "Channel.h"
+
 
 //typedef vtkGPUVolumeRayCastMapper        VolumeMapper;
 typedef vtkFixedPointVolumeRayCastMapper VolumeMapper;
 //typedef vtkVolumeTextureMapper2D         VolumeMapper;
 
 
+// The number of direction subcycles of the thinning
+static const int NUM_DIRECTIONS = 6;
+
+// One position offset in x, y and z for each of the six direction (left, right, down, up, backward, forward)
+static const int DIRECTION_OFFSETS[ NUM_DIRECTIONS ][3] = {
+	{-1,  0,  0},
+	{ 1,  0,  0},
+	{ 0, -1,  0},
+	{ 0,  1,  0},
+	{ 0,  0, -1},
+	{ 0,  0,  1}
+};
+
+
 // Create a cross of three boxes
 void Volume::createBoxCross( int _sizeX, int _sizeY, int _sizeZ )
 {
@@ -73,14 +100,7 @@ void Volume::createHollowCube( int _sizeX, int _sizeY, int _sizeZ, double _radiu
 // Convert the voxel values to either 0 or 1 by comparing them to the given threshold.
 bool Volume::readRAWFile( const std::string &_filename, int _sizeX, int _sizeY, int _sizeZ, double _threshold )
 {
-	auto imageReader = vtkSmartPointer<vtkImageReader>::New();
-	imageReader->SetFileName( _filename.c_str() );
-	imageReader->SetDataExtent( 0, _sizeX-1, 0, _sizeY-1, 0, _sizeZ-1 );
-	imageReader->SetFileDimensionality( 3 );
-	imageReader->SetDataScalarType( VTK_UNSIGNED_CHAR );
-	imageReader->Update();
-
-	bool success = copyImageDataToVolumeData( imageReader->GetOutput(), _sizeX, _sizeY, _sizeZ, _threshold );
+	bool success = copyImageDataToVolumeData( readRAWImageData( _filename, _sizeX, _sizeY, _sizeZ ), _sizeX, _sizeY, _sizeZ, _threshold );
 
 	if( !success )
 		std::cerr << "Could not read file \"" << _filename << "\"." << std::endl;
@@ -92,16 +112,63 @@ bool Volume::readRAWFile( const std::string &_filename, int _sizeX, int _sizeY,
 // Read the volume from png files, one file for each slice on the Z axis.
 // Convert the voxel values to either 0 or 1 by comparing them to the given threshold.
 bool Volume::readPNGFiles( const std::string &_filenamePattern, int _sizeX, int _sizeY, int _sizeZ, double _threshold )
+{
+	bool success = copyImageDataToVolumeData( readPNGImageData( _filenamePattern, _sizeX, _sizeY, _sizeZ ), _sizeX, _sizeY, _sizeZ, _threshold );
+
+	if( !success )
+		std::cerr << "Could not read files \"" << _filenamePattern << "\"." << std::endl;
+
+	return success;
+}
+
+
+// Read the voxel values from a raw file without thresholding them
+vtkSmartPointer<vtkImageData> Volume::readRAWImageData( const std::string &_filename, int _sizeX, int _sizeY, int _sizeZ )
+{
+	auto imageReader = vtkSmartPointer<vtkImageReader>::New();
+	imageReader->SetFileName( _filename.c_str() );
+	imageReader->SetDataExtent( 0, _sizeX-1, 0, _sizeY-1, 0, _sizeZ-1 );
+	imageReader->SetFileDimensionality( 3 );
+	imageReader->SetDataScalarType( VTK_UNSIGNED_CHAR );
+	imageReader->Update();
+
+	return imageReader->GetOutput();
+}
+
+
+// Read the voxel values from png files, one file for each slice on the Z axis, without thresholding them
+vtkSmartPointer<vtkImageData> Volume::readPNGImageData( const std::string &_filenamePattern, int _sizeX, int _sizeY, int _sizeZ )
 {
 	auto pngReader = vtkSmartPointer<vtkPNGReader>::New();
 	pngReader->SetFilePattern( _filenamePattern.c_str() );
 	pngReader->SetDataExtent( 0, _sizeX-1, 0, _sizeY-1, 0, _sizeZ-1 );
 	pngReader->Update();
 
-	bool success = copyImageDataToVolumeData( pngReader->GetOutput(), _sizeX, _sizeY, _sizeZ, _threshold );
+	return pngReader->GetOutput();
+}
+
+
+// Create the volume data from voxel values that were read before.
+// Convert the voxel values to either 0 or 1 by comparing them to the given threshold.
+bool Volume::createFromImageData( vtkImageData *_imageData, int _sizeX, int _sizeY, int _sizeZ, double _threshold )
+{
+	return copyImageDataToVolumeData( _imageData, _sizeX, _sizeY, _sizeZ, _threshold );
+}
+
+
+// Read a 2D image from a single png file. The volume data has a size of 1 in Z.
+// Convert the pixel values to either 0 or 1 by comparing them to the given threshold.
+bool Volume::readPNGFile( const std::string &_filename, int _sizeX, int _sizeY, double _threshold )
+{
+	auto pngReader = vtkSmartPointer<vtkPNGReader>::New();
+	pngReader->SetFileName( _filename.c_str() );
+	pngReader->SetDataExtent( 0, _sizeX-1, 0, _sizeY-1, 0, 0 );
+	pngReader->Update();
+
+	bool success = copyImageDataToVolumeData( pngReader->GetOutput(), _sizeX, _sizeY, 1, _threshold );
 
 	if( !success )
-		std::cerr << "Could not read files \"" << _filenamePattern << "\"." << std::endl;
+		std::cerr << "Could not read file \"" << _filename << "\"." << std::endl;
 
 	return success;
 }
@@ -140,6 +207,22 @@ bool Volume::writePNGFiles( const std::string &_filenamePattern ) const
 }
 
 
+// Write a 2D image (a volume with a size of 1 in Z) to a single png file.
+// All pixel values in that file will be set to either 0 or 255.
+bool Volume::writePNGFile( const std::string &_filename ) const
+{
+	auto imageData = vtkSmartPointer<vtkImageData>::New();
+	copyVolumeDataToImageData( imageData, 255.0);
+
+	auto pngWriter = vtkSmartPointer<vtkPNGWriter>::New();
+	pngWriter->SetFileName( _filename.c_str() );
+	pngWriter->SetInputData( imageData );
+	pngWriter->Write();
+
+	return true;
+}
+
+
 // Copy the voxels from the given image data to the stored volume data.
 // Convert the voxel values to either 0 or 1 by comparing them to the given threshold.
 bool Volume::copyImageDataToVolumeData( vtkImageData *_imageData, int _sizeX, int _sizeY, int _sizeZ, double _threshold )
@@ -211,21 +294,345 @@ void Volume::copyVolumeDataToImageData( vtkImageData *_imageData, double _scale
 // Perform the actual thinning with the help of the given lookup table
 void Volume::performThinning( const LookupTable &_lookupTable )
 {
-	// One position offset in x, y and z for each of the six direction (left, right, down, up, backward, forward)
-	static const int OFFSETS[6][3] = {
-		{-1,  0,  0},
-		{ 1,  0,  0},
-		{ 0, -1,  0},
-		{ 0,  1,  0},
-		{ 0,  0, -1},
-		{ 0,  0,  1}
-	};
+	// Thin the whole volume
+	const int regionBegin[3] = { 0, 0, 0 };
+	const int regionEnd  [3] = { m_volumeData.getSizeX(), m_volumeData.getSizeY(), m_volumeData.getSizeZ() };
+
+	performThinning( _lookupTable, regionBegin, regionEnd );
+}
+
+
+// Perform the thinning in the given number of worker processes. The volume is split into slabs along Z, one for each worker.
+// This process scatters the slabs to the workers, reduces their modified flags after each iteration and gathers the thinned slabs.
+bool Volume::performDistributedThinning( const LookupTable &_lookupTable, int _numWorkers )
+{
+	// Get the size of the stored volume data
+	int sizeX = m_volumeData.getSizeX();
+	int sizeY = m_volumeData.getSizeY();
+	int sizeZ = m_volumeData.getSizeZ();
+
+	// Each worker owns at least one plane
+	int numWorkers = std::min( _numWorkers, sizeZ );
+
+	// Thin 2D images and volumes for a single worker in this process
+	if( (sizeZ == 1) || (numWorkers <= 1) )
+	{
+		performThinning( _lookupTable );
+		return true;
+	}
+
+#ifdef _WIN32
+	std::cerr << "Distributed thinning is not supported on this platform. Thinning in a single process." << std::endl;
+
+	performThinning( _lookupTable );
+	return true;
+#else
+	// Create one channel between this process and each worker, and one channel between each two neighboring workers
+	std::vector< std::unique_ptr<Channel> > workerChannels;
+	std::vector< std::unique_ptr<Channel> > neighborChannels;
+
+	for( int workerIdx = 0; workerIdx < numWorkers; ++workerIdx )
+	{
+		workerChannels.emplace_back( new Channel );
+		if( !workerChannels.back()->create() )
+			return false;
+
+		if( workerIdx == 0 )
+			continue;
+
+		neighborChannels.emplace_back( new Channel );
+		if( !neighborChannels.back()->create() )
+			return false;
+	}
+
+	// Get the first plane of each slab. The planes are distributed evenly among the workers.
+	std::vector<int> slabBegins( numWorkers + 1 );
+	for( int workerIdx = 0; workerIdx <= numWorkers; ++workerIdx )
+		slabBegins[ workerIdx ] = static_cast<int>( static_cast<long long>( sizeZ ) * workerIdx / numWorkers );
+
+	// Start the worker processes
+	std::cout.flush();
+	std::cerr.flush();
+
+	std::vector<pid_t> workerPids;
+
+	for( int workerIdx = 0; workerIdx < numWorkers; ++workerIdx )
+	{
+		pid_t pid = fork();
+
+		if( pid < 0 )
+		{
+			std::cerr << "Could not start worker process." << std::endl;
+			break;
+		}
+
+		if( pid == 0 )
+		{
+			// -- Worker process --
+
+			// Keep only the channels to this process, and to the workers below and above
+			for( int channelIdx = 0; channelIdx < numWorkers; ++channelIdx )
+				if( channelIdx != workerIdx )
+					workerChannels[ channelIdx ]->close();
+
+			for( int channelIdx = 0; channelIdx < numWorkers-1; ++channelIdx )
+				if( (channelIdx != workerIdx-1) && (channelIdx != workerIdx) )
+					neighborChannels[ channelIdx ]->close();
+
+			workerChannels[ workerIdx ]->useEnd( 1 );
+
+			Channel *lowerChannel = nullptr;
+			Channel *upperChannel = nullptr;
+
+			if( workerIdx > 0 )
+			{
+				lowerChannel = neighborChannels[ workerIdx-1 ].get();
+				lowerChannel->useEnd( 1 );
+			}
+
+			if( workerIdx < numWorkers-1 )
+			{
+				upperChannel = neighborChannels[ workerIdx ].get();
+				upperChannel->useEnd( 0 );
+			}
+
+			int slabSizeZ = slabBegins[ workerIdx+1 ] - slabBegins[ workerIdx ];
+
+			bool success = runThinningWorker( _lookupTable, sizeX, sizeY, slabSizeZ, *workerChannels[ workerIdx ], lowerChannel, upperChannel );
+
+			// Leave without cleaning up the state that was copied from the coordinating process
+			_exit( success ? 0 : 1 );
+		}
+
+		workerPids.push_back( pid );
+	}
+
+	// -- Coordinating process --
+
+	// The neighbor channels are only used by the workers
+	for( auto &channel : neighborChannels )
+		channel->close();
+
+	for( auto &channel : workerChannels )
+		channel->useEnd( 0 );
+
+	bool success = ( static_cast<int>( workerPids.size() ) == numWorkers );
+
+	// Scatter the slabs to the workers, each with one halo plane below and above
+	for( int workerIdx = 0; success && (workerIdx < numWorkers); ++workerIdx )
+		for( int z = slabBegins[ workerIdx ] - 1; success && (z <= slabBegins[ workerIdx+1 ]); ++z )
+			success = sendPlane( *workerChannels[ workerIdx ], z );
+
+	// Reduce the modified flags of all workers after each iteration, until none of the workers modified its slab
+	while( success )
+	{
+		bool modified = false;
+
+		for( int workerIdx = 0; success && (workerIdx < numWorkers); ++workerIdx )
+		{
+			bool workerModified = false;
+			success = workerChannels[ workerIdx ]->receiveValue( workerModified );
+
+			modified = modified || workerModified;
+		}
+
+		for( int workerIdx = 0; success && (workerIdx < numWorkers); ++workerIdx )
+			success = workerChannels[ workerIdx ]->sendValue( modified );
+
+		if( !modified )
+			break;
+	}
+
+	// Gather the thinned slabs from the workers
+	for( int workerIdx = 0; success && (workerIdx < numWorkers); ++workerIdx )
+		for( int z = slabBegins[ workerIdx ]; success && (z < slabBegins[ workerIdx+1 ]); ++z )
+			success = receivePlane( *workerChannels[ workerIdx ], z );
+
+	// Close the channels, so that the workers stop in case of an error, and wait for the workers
+	for( auto &channel : workerChannels )
+		channel->close();
+
+	for( pid_t pid : workerPids )
+	{
+		int status = 0;
+		if( (waitpid( pid, &status, 0 ) != pid) || !WIFEXITED( status ) || (WEXITSTATUS( status ) != 0) )
+			success = false;
+	}
+
+	if( !success )
+		std::cerr << "Distributed thinning failed." << std::endl;
+
+	return success;
+#endif
+}
+
+
+// Run a worker process of the distributed thinning, which owns a slab of the given size.
+// The worker performs the same direction subcycles as performThinning() on its slab. To get the same result, the candidates
+// are rechecked in the same order as in a single process: each worker waits for the final lower halo plane from the worker
+// below, before it rechecks its own candidates and passes its final upper plane on to the worker above.
+bool Volume::runThinningWorker( const LookupTable &_lookupTable, int _sizeX, int _sizeY, int _slabSizeZ,
+                                Channel &_coordinatorChannel, Channel *_lowerChannel, Channel *_upperChannel )
+{
+	// Receive the slab with one halo plane below (at 0) and above (at _slabSizeZ+1)
+	Volume block;
+	block.m_volumeData.allocate( _sizeX, _sizeY, _slabSizeZ + 2 );
+
+	for( int z = 0; z < _slabSizeZ + 2; ++z )
+		if( !block.receivePlane( _coordinatorChannel, z ) )
+			return false;
+
+	// Only the voxels of the slab (without the halo planes) are thinned by this worker
+	const int regionBegin[3] = { 0     , 0     , 1             };
+	const int regionEnd  [3] = { _sizeX, _sizeY, _slabSizeZ + 1 };
+
+	// Iterate as long as any of the workers modified its slab
+	while( true )
+	{
+		bool modified = false;
+
+		for( int directionIdx = 0; directionIdx < NUM_DIRECTIONS; ++directionIdx )
+		{
+			// Gather the candidates of the slab, with the halo planes as they were at the beginning of the subcycle
+			Candidates candidates;
+			block.gatherCandidates( _lookupTable, directionIdx, regionBegin, regionEnd, candidates );
+
+			// Wait for the worker below to recheck its candidates and to send its final upper plane
+			if( _lowerChannel && !block.receivePlane( *_lowerChannel, 0 ) )
+				return false;
+
+			// Recheck and delete the candidates
+			if( block.deleteCandidates( _lookupTable, candidates ) )
+				modified = true;
+
+			// Exchange the final boundary planes with the workers above and below
+			if( _upperChannel && !block.sendPlane( *_upperChannel, _slabSizeZ ) )
+				return false;
+
+			if( _lowerChannel && !block.sendPlane( *_lowerChannel, 1 ) )
+				return false;
+
+			if( _upperChannel && !block.receivePlane( *_upperChannel, _slabSizeZ + 1 ) )
+				return false;
+		}
+
+		// Reduce the modified flags of all workers in the coordinating process
+		bool anyModified = false;
+
+		if( !_coordinatorChannel.sendValue( modified ) || !_coordinatorChannel.receiveValue( anyModified ) )
+			return false;
+
+		if( !anyModified )
+			break;
+	}
+
+	// Send the thinned slab back
+	for( int z = 1; z <= _slabSizeZ; ++z )
+		if( !block.sendPlane( _coordinatorChannel, z ) )
+			return false;
 
-	// Get the size of the stord volume data
+	return true;
+}
+
+
+// Send the plane of voxels at the given position in Z through the given channel. The position can range from -1 to size.
+bool Volume::sendPlane( Channel &_channel, int _z ) const
+{
+	int sizeX = m_volumeData.getSizeX();
+	int sizeY = m_volumeData.getSizeY();
+
+	std::vector<VolumeData::Voxel> plane( sizeX * sizeY );
+
+	for( int y = 0; y < sizeY; ++y )
+		for( int x = 0; x < sizeX; ++x )
+			plane[ sizeX * y + x ] = m_volumeData.getVoxel( x, y, _z );
+
+	return _channel.send( plane.data(), plane.size() * sizeof( VolumeData::Voxel ) );
+}
+
+
+// Receive the plane of voxels at the given position in Z through the given channel
+bool Volume::receivePlane( Channel &_channel, int _z )
+{
+	int sizeX = m_volumeData.getSizeX();
+	int sizeY = m_volumeData.getSizeY();
+
+	std::vector<VolumeData::Voxel> plane( sizeX * sizeY );
+
+	if( !_channel.receive( plane.data(), plane.size() * sizeof( VolumeData::Voxel ) ) )
+		return false;
+
+	for( int y = 0; y < sizeY; ++y )
+		for( int x = 0; x < sizeX; ++x )
+			m_volumeData.setVoxel( x, y, _z, plane[ sizeX * y + x ] );
+
+	return true;
+}
+
+
+// Incrementally re-thin this (already thinned) volume after a local edit of the given original volume.
+// The original voxels are restored within the dirty region enlarged by the given margin, and only this region is thinned again.
+bool Volume::performIncrementalThinning( const LookupTable &_lookupTable, const Volume &_originalVolume,
+                                         int _minX, int _minY, int _minZ, int _maxX, int _maxY, int _maxZ, int _margin )
+{
+	// Get the size of the stored volume data
 	int sizeX = m_volumeData.getSizeX();
 	int sizeY = m_volumeData.getSizeY();
 	int sizeZ = m_volumeData.getSizeZ();
 
+	// Check the size of the original volume
+	if( (_originalVolume.m_volumeData.getSizeX() != sizeX) ||
+	    (_originalVolume.m_volumeData.getSizeY() != sizeY) ||
+	    (_originalVolume.m_volumeData.getSizeZ() != sizeZ) )
+	{
+		std::cerr << "The original volume does not match the size of the thinned volume." << std::endl;
+		return false;
+	}
+
+	// Enlarge the dirty region by the margin (not in Z for 2D images) and clip it to the volume
+	int marginZ = (sizeZ == 1) ? 0 : _margin;
+
+	const int regionBegin[3] = {
+		std::max( _minX - _margin, 0 ),
+		std::max( _minY - _margin, 0 ),
+		std::max( _minZ - marginZ, 0 )
+	};
+
+	const int regionEnd[3] = {
+		std::min( _maxX + _margin + 1, sizeX ),
+		std::min( _maxY + _margin + 1, sizeY ),
+		std::min( _maxZ + marginZ + 1, sizeZ )
+	};
+
+	// Restore the original voxels within the region
+	for( int z = regionBegin[2]; z < regionEnd[2]; ++z )
+		for( int y = regionBegin[1]; y < regionEnd[1]; ++y )
+			for( int x = regionBegin[0]; x < regionEnd[0]; ++x )
+				m_volumeData.setVoxel( x, y, z, _originalVolume.m_volumeData.getVoxel( x, y, z ) );
+
+	// Thin the region again. The voxels outside of the region keep their thinned values.
+	performThinning( _lookupTable, regionBegin, regionEnd );
+
+	return true;
+}
+
+
+// Perform the thinning of the given region with the help of the given lookup table.
+// Only voxels within the region are deleted, but the neighborhoods may reach one voxel beyond the region.
+void Volume::performThinning( const LookupTable &_lookupTable, const int _regionBegin[3], const int _regionEnd[3] )
+{
+	// A volume with a size of 1 in Z is a 2D image. Use the dedicated 2D thinning.
+	if( m_volumeData.getSizeZ() == 1 )
+	{
+		performThinning2D( _lookupTable, _regionBegin, _regionEnd );
+		return;
+	}
+
+	// Empty regions do not need to be thinned
+	for( int i = 0; i < 3; ++i )
+		if( _regionBegin[i] >= _regionEnd[i] )
+			return;
+
 	// Iterate as long as the volume data was modified.
 	// To stop this, the volume data has to be unmodified after all six direction subcycles (not just one).
 	while( true )
@@ -234,111 +641,337 @@ void Volume::performThinning( const LookupTable &_lookupTable )
 		bool modified = false;
 
 		// Loop through all six directions (left, right, down, up, backward, forward)
-		for( int directionIdx = 0; directionIdx < 6; ++directionIdx )
+		for( int directionIdx = 0; directionIdx < NUM_DIRECTIONS; ++directionIdx )
 		{
-			// Get the position offset for the current direction
-			const int *offset = OFFSETS[ directionIdx ];
-
 			// Gather all the candidate positions for the current direction.
 			// We first gather all candidates instead of trying to delete (set to 0)
 			// the voxels immediately, because immediate deletion could lead to ripple effects 
 			// that delete more than one front voxel coming from the current direction.
 			// This is done to ensure that the thinning result is most likely to be in the middle.
-			std::deque< std::tuple<short,short,short> > candidates;
+			Candidates candidates;
+			gatherCandidates( _lookupTable, directionIdx, _regionBegin, _regionEnd, candidates );
+
+			// Recheck and delete the candidates
+			if( deleteCandidates( _lookupTable, candidates ) )
 			{
-				// Check each voxel once
-				for( int z = 0; z < sizeZ; ++z )
+				// The volume data was modified. Another iteration is needed.
+				modified = true;
+			}
+		}
+
+		// If the volume data was not modified after a all six direction subcycles, stop.
+		if( !modified )
+			break;
+	}
+}
+
+
+// Gather the positions of all voxels within the given region that are candidates for deletion in the given direction subcycle
+void Volume::gatherCandidates( const LookupTable &_lookupTable, int _directionIdx, const int _regionBegin[3], const int _regionEnd[3], Candidates &_candidates ) const
+{
+	// Get the position offset for the given direction
+	const int *offset = DIRECTION_OFFSETS[ _directionIdx ];
+
+	// The region is scanned tile by tile. If the volume data is stored in bricks, each tile is a brick, so that
+	// the neighborhoods of consecutively scanned voxels share their cache lines. Otherwise, each tile is a row.
+	int tileSize[3];
+	int tileBegin[3];
+
+	for( int i = 0; i < 3; ++i )
+	{
+		bool isRow = (i == 0);
+
+		tileSize [i] = VolumeData::IS_BRICKED ? VolumeData::BRICK_SIZE                    : ( isRow ? std::max( _regionEnd[i] - _regionBegin[i], 1 ) : 1 );
+		tileBegin[i] = VolumeData::IS_BRICKED ? VolumeData::getBrickBegin( _regionBegin[i] ) : _regionBegin[i];
+	}
+
+	// The positions and lookup table indices of the front voxels within the currently scanned tile
+	std::vector< std::tuple<short,short,short> > tilePositions   ( tileSize[0] * tileSize[1] * tileSize[2] );
+	std::vector< LookupTable::Index >            tileEntryIndices( tileSize[0] * tileSize[1] * tileSize[2] );
+
+	for( int tileZ = tileBegin[2]; tileZ < _regionEnd[2]; tileZ += tileSize[2] )
+	{
+		for( int tileY = tileBegin[1]; tileY < _regionEnd[1]; tileY += tileSize[1] )
+		{
+			for( int tileX = tileBegin[0]; tileX < _regionEnd[0]; tileX += tileSize[0] )
+			{
+				// Skip empty bricks, which are most of the bricks after the first iterations
+				if( VolumeData::IS_BRICKED && m_volumeData.isBrickEmpty( tileX, tileY, tileZ ) )
+					continue;
+
+				// Gather the positions and lookup table indices of all front voxels in the part of the current tile within the region
+				int numTileVoxels = 0;
+
+				for( int z = std::max( tileZ, _regionBegin[2] ); z < std::min( tileZ + tileSize[2], _regionEnd[2] ); ++z )
 				{
-					for( int y = 0; y < sizeY; ++y )
+					for( int y = std::max( tileY, _regionBegin[1] ); y < std::min( tileY + tileSize[1], _regionEnd[1] ); ++y )
 					{
-						for( int x = 0; x < sizeX; ++x )
+						// The row of voxels within the tile and the row of their predecessors coming from the current direction are stored contiguously
+						int rowBegin  = std::max( tileX, _regionBegin[0] );
+						int rowLength = std::min( tileX + tileSize[0], _regionEnd[0] ) - rowBegin;
+
+						const VolumeData::Voxel *row            = m_volumeData.getVoxelPointer( rowBegin, y            , z             );
+						const VolumeData::Voxel *predecessorRow = m_volumeData.getVoxelPointer( rowBegin, y + offset[1], z + offset[2] );
+
+						for( int i = 0; i < rowLength; ++i )
 						{
+							// Skip eight voxels at once, if none of them is set
+							if( (i % 8 == 0) && (i + 8 <= rowLength) )
+							{
+								std::uint64_t word;
+								std::memcpy( &word, row + i, sizeof( word ) );
+
+								if( !word )
+								{
+									i += 7;
+									continue;
+								}
+							}
+
 							// The voxel has to be set to 1
-							if( !m_volumeData.getVoxel( x, y, z ) )
+							if( !row[i] )
 								continue;
 
-							// The predecessor voxel coming from the current direction has to be 0
-							if( m_volumeData.getVoxel( x + offset[0], y + offset[1], z + offset[2] ) )
+							// The predecessor voxel coming from the current direction has to be 0. The predecessor in x might lie outside of the row.
+							int predecessorIdx = i + offset[0];
+
+							if( (predecessorIdx >= 0) && (predecessorIdx < rowLength) ? predecessorRow[ predecessorIdx ]
+							                                                          : m_volumeData.getVoxel( rowBegin + predecessorIdx, y, z ) )
 								continue;
 
 							// Get the local neighborhood of the current voxel
+							int x = rowBegin + i;
+
 							VolumeData::Voxel neighborhood[27];
 							getNeighborhood( x, y, z, neighborhood );
 
-							// Check the lookup table to see if the voxel / the neighborhood fulfills the Euler criterion,
-							// the Simple Point criterion and - depending on the lookup table - the medial axis endpoint or
-							// medial surface point criterions
-							if( _lookupTable.getEntry( neighborhood ) )
-								candidates.push_back( std::make_tuple( x, y, z ) );
+							tilePositions   [ numTileVoxels ] = std::make_tuple( x, y, z );
+							tileEntryIndices[ numTileVoxels ] = LookupTable::getEntryIdx( neighborhood );
+							++numTileVoxels;
 						}
 					}
 				}
+
+				// Check the lookup table to see if the voxels / the neighborhoods fulfill the Euler criterion,
+				// the Simple Point criterion and - depending on the lookup table - the medial axis endpoint or
+				// medial surface point criterions. The tile is queried in batches, so that the random accesses
+				// to the lookup table overlap instead of waiting for each other.
+				for( int batchBegin = 0; batchBegin < numTileVoxels; batchBegin += LookupTable::MAX_BATCH_SIZE )
+				{
+					int batchSize = std::min( numTileVoxels - batchBegin, LookupTable::MAX_BATCH_SIZE );
+
+					LookupTable::EntryMask entryMask = _lookupTable.getEntries( &tileEntryIndices[ batchBegin ], batchSize );
+
+					for( int i = 0; i < batchSize; ++i )
+						if( (entryMask >> i) & 1 )
+							_candidates.push_back( tilePositions[ batchBegin + i ] );
+				}
+			}
+		}
+	}
+
+	// Sort the candidates gathered brick by brick into the order of rows, so that they are rechecked in the same order
+	// for every layout of the volume data. The recheck order determines, which of two dependent candidates is deleted.
+	if( VolumeData::IS_BRICKED )
+	{
+		std::sort( _candidates.begin(), _candidates.end(), []( const std::tuple<short,short,short> &_a, const std::tuple<short,short,short> &_b )
+		{
+			return std::make_tuple( std::get<2>( _a ), std::get<1>( _a ), std::get<0>( _a ) ) <
+			       std::make_tuple( std::get<2>( _b ), std::get<1>( _b ), std::get<0>( _b ) );
+		} );
+	}
+}
+
+
+// Recheck all candidate positions in the given order and delete the candidates that still fulfill the criterions.
+// The deletion of one candidate voxel might invalidate a later candidate. Returns true, if any voxel was deleted.
+bool Volume::deleteCandidates( const LookupTable &_lookupTable, const Candidates &_candidates )
+{
+	bool modified = false;
+
+	for( const auto &candidate : _candidates )
+	{
+		// Get the position of the current candidate
+		int x = std::get<0>( candidate );
+		int y = std::get<1>( candidate );
+		int z = std::get<2>( candidate );
+
+		// Get the local neighborhood of the current candidate voxel, again.
+		// Though, because of earlier deletions, this neighborhood might have changed in the meantime.
+		VolumeData::Voxel neighborhood[27];
+		getNeighborhood( x, y, z, neighborhood );
+
+		// Recheck the neighborhood
+		if( _lookupTable.getEntry( neighborhood ) )
+		{
+			// Delete (set to 0) the candidate voxel
+			m_volumeData.setVoxel( x, y, z, 0 );
+
+			modified = true;
+		}
+	}
+
+	return modified;
+}
+
+
+// Perform the thinning of the given region of a 2D image (a volume with a size of 1 in Z) with four direction subcycles.
+// This works like the thinning of a volume, but the backward and forward subcycles are skipped (there is nothing
+// to thin in Z), the pixels are looked up in a 2D lookup table of only 256 entries and the rows are scanned
+// eight pixels at a time.
+void Volume::performThinning2D( const LookupTable &_lookupTable, const int _regionBegin[3], const int _regionEnd[3] )
+{
+	// One position offset in x and y for each of the four directions (left, right, down, up)
+	static const int OFFSETS[4][2] = {
+		{-1,  0},
+		{ 1,  0},
+		{ 0, -1},
+		{ 0,  1}
+	};
+
+	// The number of pixels that are scanned at once (one pixel per byte of a 64 bit word)
+	static const int WORD_SIZE = 8;
+
+	// Empty regions do not need to be thinned
+	if( (_regionBegin[0] >= _regionEnd[0]) || (_regionBegin[1] >= _regionEnd[1]) )
+		return;
+
+	// Derive the 2D lookup table from the middle slice of the given lookup table
+	LookupTable2D lookupTable2D;
+	lookupTable2D.create( _lookupTable );
+
+	// Get the size of the region
+	int regionSizeX = _regionEnd[0] - _regionBegin[0];
+	int regionSizeY = _regionEnd[1] - _regionBegin[1];
+
+	// Copy the pixels of the region and the one pixel wide ring around it into a buffer of rows.
+	// Each row is padded with 0s, so that a whole word can be read at every pixel position, including the predecessor positions.
+	int rowSize = ( (regionSizeX + 2 + WORD_SIZE) / WORD_SIZE + 1 ) * WORD_SIZE;
+
+	std::vector<VolumeData::Voxel> pixels( rowSize * (regionSizeY + 2), 0 );
+
+	// Get the pixel at the given image position. The position can range from one pixel before to one pixel behind the region.
+	auto pixel = [&]( int _x, int _y ) -> VolumeData::Voxel & { return pixels[ rowSize * (_y - _regionBegin[1] + 1) + (_x - _regionBegin[0] + 1) ]; };
+
+	for( int y = _regionBegin[1] - 1; y <= _regionEnd[1]; ++y )
+		for( int x = _regionBegin[0] - 1; x <= _regionEnd[0]; ++x )
+			pixel( x, y ) = m_volumeData.getVoxel( x, y, 0 );
+
+	// Get the index of the 2D lookup table entry for the 3x3 neighborhood around the given pixel position
+	auto getEntryIdx = [&]( int _x, int _y ) -> LookupTable2D::Index
+	{
+		const VolumeData::Voxel *prevRow = &pixel( _x, _y-1 );
+		const VolumeData::Voxel *currRow = &pixel( _x, _y   );
+		const VolumeData::Voxel *nextRow = &pixel( _x, _y+1 );
+
+		return static_cast<LookupTable2D::Index>(
+			(prevRow[-1] << 0) | (prevRow[0] << 1) | (prevRow[1] << 2) |
+			(currRow[-1] << 3) |  /* ignored */      (currRow[1] << 4) |
+			(nextRow[-1] << 5) | (nextRow[0] << 6) | (nextRow[1] << 7)
+		);
+	};
+
+	// Read a word of pixels starting at the given position
+	auto getWord = [&]( int _x, int _y ) -> std::uint64_t
+	{
+		std::uint64_t word;
+		std::memcpy( &word, &pixel( _x, _y ), sizeof( word ) );
+		return word;
+	};
+
+	// The positions of the candidate pixels of the current direction
+	std::vector< std::pair<int,int> > candidates;
+
+	// Iterate as long as the image was modified.
+	// To stop this, the image has to be unmodified after all four direction subcycles (not just one).
+	while( true )
+	{
+		// The image was not modified so far
+		bool modified = false;
+
+		// Loop through all four directions (left, right, down, up)
+		for( int directionIdx = 0; directionIdx < 4; ++directionIdx )
+		{
+			// Get the position offset for the current direction
+			const int *offset = OFFSETS[ directionIdx ];
+
+			// Gather all the candidate positions for the current direction (see performThinning)
+			candidates.clear();
+
+			for( int y = _regionBegin[1]; y < _regionEnd[1]; ++y )
+			{
+				for( int x = _regionBegin[0]; x < _regionEnd[0]; x += WORD_SIZE )
+				{
+					// Find all front pixels of the word at once: the pixel has to be set to 1 and the
+					// predecessor pixel coming from the current direction has to be 0.
+					std::uint64_t frontWord = getWord( x, y ) & ~getWord( x + offset[0], y + offset[1] );
+
+					// Skip words without any front pixels
+					if( !frontWord )
+						continue;
+
+					// Check the single pixels of the word within the region
+					int numPixels = std::min( _regionEnd[0] - x, WORD_SIZE );
+
+					for( int i = 0; i < numPixels; ++i )
+					{
+						if( !pixel( x+i, y ) || pixel( x+i + offset[0], y + offset[1] ) )
+							continue;
+
+						// Check the 2D lookup table
+						if( lookupTable2D.getEntry( getEntryIdx( x+i, y ) ) )
+							candidates.push_back( std::make_pair( x+i, y ) );
+					}
+				}
 			}
 
-			// Recheck all candidate positions. The deletion of one candidate voxel might invalidate a later candidate.
+			// Recheck all candidate positions. The deletion of one candidate pixel might invalidate a later candidate.
 			for( const auto &candidate : candidates )
 			{
-				// Get the position of the current candidate
-				int x = std::get<0>( candidate );
-				int y = std::get<1>( candidate );
-				int z = std::get<2>( candidate );
-
-				// Get the local neighborhood of the current candidate voxel, again.
-				// Though, because of earlier deletions, this neighborhood might have changed in the meantime.
-				VolumeData::Voxel neighborhood[27];
-				getNeighborhood( x, y, z, neighborhood );
-
-				// Recheck the neighborhood
-				if( _lookupTable.getEntry( neighborhood ) )
+				if( lookupTable2D.getEntry( getEntryIdx( candidate.first, candidate.second ) ) )
 				{
-					// Delete (set to 0) the candidate voxel
-					m_volumeData.setVoxel( x, y, z, 0 );
+					// Delete (set to 0) the candidate pixel
+					pixel( candidate.first, candidate.second ) = 0;
 
-					// The volume data was modified. Another iteration is needed.
+					// The image was modified. Another iteration is needed.
 					modified = true;
 				}
 			}
 		}
 
-		// If the volume data was not modified after a all six direction subcycles, stop.
+		// If the image was not modified after all four direction subcycles, stop.
 		if( !modified )
 			break;
 	}
+
+	// Copy the thinned pixels of the region back into the volume data
+	for( int y = _regionBegin[1]; y < _regionEnd[1]; ++y )
+		for( int x = _regionBegin[0]; x < _regionEnd[0]; ++x )
+			m_volumeData.setVoxel( x, y, 0, pixel( x, y ) );
 }
 
 
 // Get the 3x3x3 neighborhood of voxels around the given voxel position
 void Volume::getNeighborhood( int _x, int _y, int _z, VolumeData::Voxel _neighborhood[27] ) const
 {
-	_neighborhood[ 0] = m_volumeData.getVoxel( _x-1, _y-1, _z-1 );
-	_neighborhood[ 1] = m_volumeData.getVoxel( _x  , _y-1, _z-1 );
-	_neighborhood[ 2] = m_volumeData.getVoxel( _x+1, _y-1, _z-1 );
-	_neighborhood[ 3] = m_volumeData.getVoxel( _x-1, _y  , _z-1 );
-	_neighborhood[ 4] = m_volumeData.getVoxel( _x  , _y  , _z-1 );
-	_neighborhood[ 5] = m_volumeData.getVoxel( _x+1, _y  , _z-1 );
-	_neighborhood[ 6] = m_volumeData.getVoxel( _x-1, _y+1, _z-1 );
-	_neighborhood[ 7] = m_volumeData.getVoxel( _x  , _y+1, _z-1 );
-	_neighborhood[ 8] = m_volumeData.getVoxel( _x+1, _y+1, _z-1 );
-
-	_neighborhood[ 9] = m_volumeData.getVoxel( _x-1, _y-1, _z   );
-	_neighborhood[10] = m_volumeData.getVoxel( _x  , _y-1, _z   );
-	_neighborhood[11] = m_volumeData.getVoxel( _x+1, _y-1, _z   );
-	_neighborhood[12] = m_volumeData.getVoxel( _x-1, _y  , _z   );
-	_neighborhood[13] = m_volumeData.getVoxel( _x  , _y  , _z   );
-	_neighborhood[14] = m_volumeData.getVoxel( _x+1, _y  , _z   );
-	_neighborhood[15] = m_volumeData.getVoxel( _x-1, _y+1, _z   );
-	_neighborhood[16] = m_volumeData.getVoxel( _x  , _y+1, _z   );
-	_neighborhood[17] = m_volumeData.getVoxel( _x+1, _y+1, _z   );
-
-	_neighborhood[18] = m_volumeData.getVoxel( _x-1, _y-1, _z+1 );
-	_neighborhood[19] = m_volumeData.getVoxel( _x  , _y-1, _z+1 );
-	_neighborhood[20] = m_volumeData.getVoxel( _x+1, _y-1, _z+1 );
-	_neighborhood[21] = m_volumeData.getVoxel( _x-1, _y  , _z+1 );
-	_neighborhood[22] = m_volumeData.getVoxel( _x  , _y  , _z+1 );
-	_neighborhood[23] = m_volumeData.getVoxel( _x+1, _y  , _z+1 );
-	_neighborhood[24] = m_volumeData.getVoxel( _x-1, _y+1, _z+1 );
-	_neighborhood[25] = m_volumeData.getVoxel( _x  , _y+1, _z+1 );
-	_neighborhood[26] = m_volumeData.getVoxel( _x+1, _y+1, _z+1 );
+	m_volumeData.getNeighborhood( _x, _y, _z, _neighborhood );
+}
+
+
+// Get the indices of all set voxels (x + sizeX * (y + sizeY * z)) in ascending order
+void Volume::getSetVoxelIndices( std::vector<long long> &_voxelIndices ) const
+{
+	int sizeX = m_volumeData.getSizeX();
+	int sizeY = m_volumeData.getSizeY();
+	int sizeZ = m_volumeData.getSizeZ();
+
+	_voxelIndices.clear();
+
+	for( int z = 0; z < sizeZ; ++z )
+		for( int y = 0; y < sizeY; ++y )
+			for( int x = 0; x < sizeX; ++x )
+				if( m_volumeData.getVoxel( x, y, z ) )
+					_voxelIndices.push_back( x + sizeX * ( y + static_cast<long long>( sizeY ) * z ) );
 }
 
 
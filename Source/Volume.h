@@ -3,6 +3,9 @@
 
 
 #include <string>
+#include <tuple>
+#include <deque>
+#include <vector>
 
 #include <vtkSmartPointer.h>
 #include <vtkImageData.h>
@@ -12,12 +15,19 @@
 #include "LookupTable.h"
 
 
+class Channel;
+
+
 // A Volume stores a three-dimensional array of digital voxels (set to either 0 or 1)
 // and offers methods for creating, reading, writing and thinning of this volume data.
 // Additionally, there is a method to include a copy of this volume into the rendering pipeline.
 //
 class Volume
 {
+	public:
+		// The positions of voxels that are candidates for deletion, in the order in which they are rechecked
+		typedef std::deque< std::tuple<short,short,short> > Candidates;
+
 	public:
 		// Create the volume data
 		void createBoxCross  ( int _sizeX, int _sizeY, int _sizeZ );
@@ -28,14 +38,43 @@ class Volume
 		bool readRAWFile ( const std::string &_filename       , int _sizeX, int _sizeY, int _sizeZ, double _threshold );
 		bool readPNGFiles( const std::string &_filenamePattern, int _sizeX, int _sizeY, int _sizeZ, double _threshold );
 
+		// Read the voxel values from file(s) without thresholding them, e.g. to create several volumes with different thresholds
+		static vtkSmartPointer<vtkImageData> readRAWImageData( const std::string &_filename       , int _sizeX, int _sizeY, int _sizeZ );
+		static vtkSmartPointer<vtkImageData> readPNGImageData( const std::string &_filenamePattern, int _sizeX, int _sizeY, int _sizeZ );
+
+		// Create the volume data from voxel values that were read before.
+		// Voxels are set to either 0 or 1 by comparing the voxel values to the given threshold. The image data is only read.
+		bool createFromImageData( vtkImageData *_imageData, int _sizeX, int _sizeY, int _sizeZ, double _threshold );
+
+		// Read a 2D image from a single png file. The volume data has a size of 1 in Z.
+		bool readPNGFile( const std::string &_filename, int _sizeX, int _sizeY, double _threshold );
+
 		// Write the volume data to file(s).
 		// All voxel values in that file will be set to either 0 or 255.
 		bool writeRAWFile ( const std::string &_filename        ) const;
 		bool writePNGFiles( const std::string &_filenamePattern ) const;
+		bool writePNGFile ( const std::string &_filename        ) const;
 
-		// Perform the actual thinning with the help of the given lookup table
+		// Perform the actual thinning with the help of the given lookup table.
+		// A volume with a size of 1 in Z is thinned as a 2D image.
 		void performThinning( const LookupTable &_lookupTable );
 
+		// Perform the thinning in the given number of worker processes. The volume is split into slabs along Z, one for each worker.
+		// The workers exchange their boundary planes after each direction subcycle and reduce their modified flags after each iteration.
+		// The result is the same as the result of performThinning(). Without support for processes, the thinning is done in this process.
+		bool performDistributedThinning( const LookupTable &_lookupTable, int _numWorkers );
+
+		// Incrementally re-thin this (already thinned) volume after a local edit of the given original volume.
+		// The original voxels are restored within the dirty region (from min to max, inclusive) enlarged by the given margin,
+		// and only this region is thinned again until it converges. Voxels outside of the region keep their thinned values.
+		// The margin should be at least half the thickness of the structures around the dirty region. Within the region,
+		// the result may differ from thinning the whole original volume again, since the surrounding skeleton stays fixed.
+		bool performIncrementalThinning( const LookupTable &_lookupTable, const Volume &_originalVolume,
+		                                 int _minX, int _minY, int _minZ, int _maxX, int _maxY, int _maxZ, int _margin );
+
+		// Get the indices of all set voxels (x + sizeX * (y + sizeY * z)) in ascending order
+		void getSetVoxelIndices( std::vector<long long> &_voxelIndices ) const;
+
 		// Add a copy of this volume to the given renderer
 		void addVolumeCopyToRenderer( vtkRenderer *_renderer ) const;
 
@@ -44,6 +83,28 @@ class Volume
 		bool copyImageDataToVolumeData( vtkImageData *_imageData, int _sizeX, int _sizeY, int _sizeZ, double _threshold );
 		void copyVolumeDataToImageData( vtkImageData *_imageData, double _scale = 1.0 ) const;
 
+		// Perform the thinning of the given region (from begin to end, exclusive) with the help of the given lookup table
+		void performThinning  ( const LookupTable &_lookupTable, const int _regionBegin[3], const int _regionEnd[3] );
+
+		// Gather the positions of all voxels within the given region that are candidates for deletion in the given direction subcycle
+		void gatherCandidates( const LookupTable &_lookupTable, int _directionIdx, const int _regionBegin[3], const int _regionEnd[3], Candidates &_candidates ) const;
+
+		// Recheck all candidate positions in the given order and delete the candidates that still fulfill the criterions.
+		// Returns true, if any voxel was deleted.
+		bool deleteCandidates( const LookupTable &_lookupTable, const Candidates &_candidates );
+
+		// Run a worker process of the distributed thinning, which owns a slab of the given size and communicates
+		// with the coordinating process and the workers of the neighboring slabs below and above (if any)
+		static bool runThinningWorker( const LookupTable &_lookupTable, int _sizeX, int _sizeY, int _slabSizeZ,
+		                               Channel &_coordinatorChannel, Channel *_lowerChannel, Channel *_upperChannel );
+
+		// Send/receive the plane of voxels at the given position in Z through the given channel
+		bool sendPlane   ( Channel &_channel, int _z ) const;
+		bool receivePlane( Channel &_channel, int _z );
+
+		// Perform the thinning of the given region of a 2D image (a volume with a size of 1 in Z) with four direction subcycles
+		void performThinning2D( const LookupTable &_lookupTable, const int _regionBegin[3], const int _regionEnd[3] );
+
 		// Get the 3x3x3 neighborhood of voxels around the given voxel position
 		void getNeighborhood( int _x, int _y, int _z, VolumeData::Voxel _neighborhood[27] ) const;
 
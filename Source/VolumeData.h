@@ -3,12 +3,19 @@
 
 
 #include <vector>
+#include <cstdint>
+#include <cstring>
 
 
 // A VolumeData is a wrapper for a three-dimensional array of digital voxels (set to either 0 or 1), stored as a one-dimensional vector.
 // Additionally to the payload volume, a one voxel wide border of 0s is stored at each of the six sides. This is done for speedup purposes.
 // From the outside this class works like a regular three-dimensional array without borders, except that it is allowed to get border voxels.
 //
+// By default, the voxels are stored in plain order (x fastest, then y, then z). If OPENTHINNING_BRICKED_VOLUMEDATA is defined,
+// the voxels are stored in cubic bricks of 8x8x8 voxels instead (x fastest within a brick, and the bricks in x, y, z order).
+// Then, a 3x3x3 neighborhood mostly lies within one brick of 512 bytes, instead of spreading over three planes of the volume
+// that are (sizeX+2)*(sizeY+2) bytes apart.
+//
 class VolumeData
 {
 	public:
@@ -17,14 +24,40 @@ class VolumeData
 		// The types int and unsigned int are larger but not faster.
 		typedef unsigned char Voxel;
 
+#ifdef OPENTHINNING_BRICKED_VOLUMEDATA
+		// Whether the voxels are stored in bricks, and the size of a brick in each dimension (including the borders)
+		static const bool IS_BRICKED = true;
+		static const int  BRICK_SIZE = 8;
+#else
+		static const bool IS_BRICKED = false;
+		static const int  BRICK_SIZE = 1;
+#endif
+
 	public:
 		// Allocate memory for all voxels (payload and borders). The given size is meant without borders.
 		// All voxels are initialized to 0 but may be set to 1 afterwards. The border voxels should always stay 0.
 		inline void allocate( int _sizeX, int _sizeY, int _sizeZ )
 		{
+#ifdef OPENTHINNING_BRICKED_VOLUMEDATA
+			// Get the number of bricks that cover the payload volume and the borders
+			int numBricksX = (_sizeX + 2 + BRICK_SIZE-1) / BRICK_SIZE;
+			int numBricksY = (_sizeY + 2 + BRICK_SIZE-1) / BRICK_SIZE;
+			int numBricksZ = (_sizeZ + 2 + BRICK_SIZE-1) / BRICK_SIZE;
+
+			// Allocate enough memory for all bricks and initialize the voxels to 0
+			m_voxels.clear();
+			m_voxels.resize( numBricksZ * numBricksY * numBricksX * (BRICK_SIZE * BRICK_SIZE * BRICK_SIZE), 0 );
+
+			// Precompute the part of the index in the stored vector for each position in each dimension (including the borders).
+			// The index of a voxel is the sum of the three parts, which is cheaper than computing the brick and the position within it.
+			computeIdxOffsets( _sizeX + 2, 1                      , 1                      , m_idxOffsetsX );
+			computeIdxOffsets( _sizeY + 2, BRICK_SIZE             , numBricksX             , m_idxOffsetsY );
+			computeIdxOffsets( _sizeZ + 2, BRICK_SIZE * BRICK_SIZE, numBricksX * numBricksY, m_idxOffsetsZ );
+#else
 			// Allocate enough memory for the payload volume and the borders and initialize the voxels to 0
 			m_voxels.clear();
 			m_voxels.resize( (_sizeZ+2) * (_sizeY+2) * (_sizeX+2), 0 );
+#endif
 
 			// Store the size of the payload volume (with borders). The border is always one voxel wide at each of the six sides of the payload volume.
 			m_sizeX = _sizeX;
@@ -36,14 +69,101 @@ class VolumeData
 		inline void  setVoxel( int _x, int _y, int _z, Voxel _voxel )       {        m_voxels[ getVoxelIdx( _x, _y, _z ) ] = _voxel; }
 		inline Voxel getVoxel( int _x, int _y, int _z               ) const { return m_voxels[ getVoxelIdx( _x, _y, _z ) ]         ; }
 
+		// Get a pointer to the voxel at the given position. The position can range from -1 to size.
+		// The following voxels in x are stored contiguously up to the end of the row, or up to the end of the brick, if the voxels are stored in bricks.
+		inline const Voxel *getVoxelPointer( int _x, int _y, int _z ) const { return &m_voxels[ getVoxelIdx( _x, _y, _z ) ]; }
+
+		// Check, whether all voxels of the brick that contains the given position are 0. The position can range from -1 to size.
+		// Without bricks, this is never the case.
+		inline bool isBrickEmpty( int _x, int _y, int _z ) const
+		{
+#ifdef OPENTHINNING_BRICKED_VOLUMEDATA
+			// Combine the voxels of the brick in words of eight voxels
+			const Voxel  *brick = &m_voxels[ getVoxelIdx( getBrickBegin( _x ), getBrickBegin( _y ), getBrickBegin( _z ) ) ];
+			std::uint64_t voxels = 0;
+
+			for( int wordIdx = 0; wordIdx < (BRICK_SIZE * BRICK_SIZE * BRICK_SIZE) / 8; ++wordIdx )
+			{
+				std::uint64_t word;
+				std::memcpy( &word, brick + 8 * wordIdx, sizeof( word ) );
+
+				voxels |= word;
+			}
+
+			return !voxels;
+#else
+			(void)_x; (void)_y; (void)_z;
+			return false;
+#endif
+		}
+
+		// Get the 3x3x3 neighborhood of voxels around the given voxel position. The position can range from 0 to size-1.
+		// The neighborhood is ordered like the voxels (x fastest, then y, then z).
+		inline void getNeighborhood( int _x, int _y, int _z, Voxel _neighborhood[27] ) const
+		{
+#ifdef OPENTHINNING_BRICKED_VOLUMEDATA
+			// Sum up the precomputed index parts of the three positions around the given position in each dimension
+			const int *idxOffsetsX = &m_idxOffsetsX[ _x ];
+			const int *idxOffsetsY = &m_idxOffsetsY[ _y ];
+			const int *idxOffsetsZ = &m_idxOffsetsZ[ _z ];
+
+			for( int z = 0; z < 3; ++z )
+			{
+				for( int y = 0; y < 3; ++y )
+				{
+					const Voxel *row = &m_voxels[ idxOffsetsZ[z] + idxOffsetsY[y] ];
+
+					_neighborhood[ 9*z + 3*y + 0 ] = row[ idxOffsetsX[0] ];
+					_neighborhood[ 9*z + 3*y + 1 ] = row[ idxOffsetsX[1] ];
+					_neighborhood[ 9*z + 3*y + 2 ] = row[ idxOffsetsX[2] ];
+				}
+			}
+#else
+			// Read the voxels relative to the first voxel of the neighborhood, with a fixed step between rows and planes
+			const Voxel *first   = &m_voxels[ getVoxelIdx( _x-1, _y-1, _z-1 ) ];
+			int          strideY = m_sizeX+2;
+			int          strideZ = strideY * (m_sizeY+2);
+
+			for( int z = 0; z < 3; ++z )
+			{
+				for( int y = 0; y < 3; ++y )
+				{
+					const Voxel *row = first + strideZ * z + strideY * y;
+
+					_neighborhood[ 9*z + 3*y + 0 ] = row[0];
+					_neighborhood[ 9*z + 3*y + 1 ] = row[1];
+					_neighborhood[ 9*z + 3*y + 2 ] = row[2];
+				}
+			}
+#endif
+		}
+
 		// Get the size of the payload volume (without borders)
 		inline int getSizeX() const { return m_sizeX; }
 		inline int getSizeY() const { return m_sizeY; }
 		inline int getSizeZ() const { return m_sizeZ; }
 
+		// Get the first position of the brick that contains the given position.
+		// Like the bricks, the returned position includes the border, i.e. it may be -1.
+		static inline int getBrickBegin( int _position ) { return ( (_position+1) / BRICK_SIZE ) * BRICK_SIZE - 1; }
+
 	private:
 		// Calculate the index in the stored vector
+#ifdef OPENTHINNING_BRICKED_VOLUMEDATA
+		inline int getVoxelIdx( int _x, int _y, int _z ) const { return m_idxOffsetsX[ _x+1 ] + m_idxOffsetsY[ _y+1 ] + m_idxOffsetsZ[ _z+1 ]; }
+
+		// Compute the parts of the index in the stored vector for all positions of one dimension (including the borders),
+		// given the step between two neighboring voxels within a brick and between two neighboring bricks (in bricks) in this dimension
+		static inline void computeIdxOffsets( int _size, int _voxelStride, int _brickStride, std::vector<int> &_idxOffsets )
+		{
+			_idxOffsets.resize( _size );
+
+			for( int position = 0; position < _size; ++position )
+				_idxOffsets[ position ] = (BRICK_SIZE * BRICK_SIZE * BRICK_SIZE) * _brickStride * (position / BRICK_SIZE) + _voxelStride * (position % BRICK_SIZE);
+		}
+#else
 		inline int getVoxelIdx( int _x, int _y, int _z ) const { return (m_sizeX+2) * ( (m_sizeY+2) * (_z+1) + (_y+1) ) + (_x+1); }
+#endif
 
 	private:
 		// A one-dimensional vector of voxels representing a three-dimensional array of size (1 + m_sizeX + 1) x (1 + m_sizeY + 1) x (1 + m_sizeZ + 1)
@@ -53,6 +173,13 @@ class VolumeData
 		int m_sizeX = 0;
 		int m_sizeY = 0;
 		int m_sizeZ = 0;
+
+#ifdef OPENTHINNING_BRICKED_VOLUMEDATA
+		// The parts of the index in the stored vector for each position in each dimension (including the borders)
+		std::vector<int> m_idxOffsetsX;
+		std::vector<int> m_idxOffsetsY;
+		std::vector<int> m_idxOffsetsZ;
+#endif
 };
 
 
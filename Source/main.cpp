@@ -1,5 +1,14 @@
 #include <iostream>
 #include <string>
+#include <vector>
+#include <fstream>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <sstream>
+#include <algorithm>
+#include <iterator>
+#include <cstdio>
 
 #include <vtkSmartPointer.h>
 #include <vtkRenderer.h>
@@ -9,10 +18,380 @@
 
 #include "Volume.h"
 #include "LookupTable.h"
+#include "BoundedQueue.h"
 
 
 static const char DEFAULT_LOOKUP_TABLE_FILENAME[] = "../../Data/LookupTables/Thinning_Simple.bin";
 
+// The maximum number of volumes that wait between two stages of the batch pipeline
+static const int BATCH_QUEUE_CAPACITY = 2;
+
+
+// A volume of a batch, which is passed from stage to stage of the batch pipeline
+struct BatchVolume
+{
+	std::string inputFilename;
+	std::string outputFilename;
+	Volume      volume;
+	bool        valid = false;
+};
+
+
+// Get the filename for the given index from a printf-like filename pattern (e.g. "Image%03i.png")
+static std::string getFilename( const std::string &_filenamePattern, int _index )
+{
+	std::vector<char> filename( _filenamePattern.length() + 64 );
+	std::snprintf( filename.data(), filename.size(), _filenamePattern.c_str(), _index );
+
+	return filename.data();
+}
+
+
+// Read the volume from png files or a raw file, depending on the suffix of the filename
+static bool readVolume( Volume &_volume, const std::string &_filename, int _sizeX, int _sizeY, int _sizeZ, double _threshold )
+{
+	// Check, if the suffix of the filename is "png" (lower case). Read png or raw file(s) accordingly.
+	if( _filename.substr( _filename.length() - 3 ) == "png" )
+		return _volume.readPNGFiles( _filename, _sizeX, _sizeY, _sizeZ, _threshold );
+	else
+		return _volume.readRAWFile ( _filename, _sizeX, _sizeY, _sizeZ, _threshold );
+}
+
+
+// Write the volume to png files or a raw file, depending on the suffix of the filename
+static bool writeVolume( const Volume &_volume, const std::string &_filename )
+{
+	// Check, if the suffix of the filename is "png" (lower case). Write png or raw file(s) accordingly.
+	if( _filename.substr( _filename.length() - 3 ) == "png" )
+		return _volume.writePNGFiles( _filename );
+	else
+		return _volume.writeRAWFile ( _filename );
+}
+
+
+// Thin a batch of 2D images, each read from and written to a single png file.
+// Every image is thinned on its own with the dedicated 2D thinning instead of being stacked into one volume.
+static int thinImages( const std::string &_lookupTableFilename, const std::string &_inputFilenamePattern,
+                       int _sizeX, int _sizeY, int _numImages, double _threshold, const std::string &_outputFilenamePattern )
+{
+	// -- Read the lookup table --
+
+	std::cout << "Reading lookup table \"" << _lookupTableFilename << "\"" << std::endl;
+
+	LookupTable lookupTable;
+
+	if( !lookupTable.readFile( _lookupTableFilename ) )
+		return -1;
+
+	// -- Read, thin and write each image --
+
+	for( int imageIdx = 0; imageIdx < _numImages; ++imageIdx )
+	{
+		std::string inputFilename  = getFilename( _inputFilenamePattern , imageIdx );
+		std::string outputFilename = getFilename( _outputFilenamePattern, imageIdx );
+
+		std::cout << "Thinning image \"" << inputFilename << "\" to \"" << outputFilename << "\"" << std::endl;
+
+		Volume image;
+
+		if( !image.readPNGFile( inputFilename, _sizeX, _sizeY, _threshold ) )
+			return -2;
+
+		image.performThinning( lookupTable );
+
+		if( !image.writePNGFile( outputFilename ) )
+			return -3;
+	}
+
+	return 0;
+}
+
+
+// Check, if the filename is the one of a list file, i.e. if its suffix is "txt" (lower case)
+static bool isListFilename( const std::string &_filename )
+{
+	return (_filename.length() >= 3) && (_filename.substr( _filename.length() - 3 ) == "txt");
+}
+
+
+// Thin a batch of volumes in a pipeline of three overlapping stages: while the current volume is thinned,
+// the next volume is read in a reader thread, and the previous volume is written in a writer thread.
+// The input volumes are either given by a list file (ending with "txt") with one filename per line,
+// or by a filename pattern and the first and last index. The output filenames are formatted with the same index.
+static int thinVolumes( const std::string &_lookupTableFilename, const std::string &_inputFilenames,
+                        int _sizeX, int _sizeY, int _sizeZ, double _threshold, const std::string &_outputFilenamePattern,
+                        int _firstIdx, int _lastIdx )
+{
+	// -- Read the lookup table --
+
+	std::cout << "Reading lookup table \"" << _lookupTableFilename << "\"" << std::endl;
+
+	LookupTable lookupTable;
+
+	if( !lookupTable.readFile( _lookupTableFilename ) )
+		return -1;
+
+	// -- Get the input and output filenames --
+
+	std::vector<std::string> inputFilenames;
+	std::vector<std::string> outputFilenames;
+
+	if( isListFilename( _inputFilenames ) )
+	{
+		std::ifstream ifs( _inputFilenames );
+		if( !ifs.is_open() )
+		{
+			std::cerr << "Could not open file \"" << _inputFilenames << "\"." << std::endl;
+			return -2;
+		}
+
+		std::string line;
+		while( std::getline( ifs, line ) )
+		{
+			if( line.empty() )
+				continue;
+
+			outputFilenames.push_back( getFilename( _outputFilenamePattern, static_cast<int>( inputFilenames.size() ) ) );
+			inputFilenames .push_back( line );
+		}
+	}
+	else
+	{
+		for( int idx = _firstIdx; idx <= _lastIdx; ++idx )
+		{
+			inputFilenames .push_back( getFilename( _inputFilenames       , idx ) );
+			outputFilenames.push_back( getFilename( _outputFilenamePattern, idx ) );
+		}
+	}
+
+	if( inputFilenames.empty() )
+	{
+		std::cerr << "No input volumes were given by \"" << _inputFilenames << "\"." << std::endl;
+		return -2;
+	}
+
+	// -- Run the pipeline stages --
+
+	BoundedQueue< std::unique_ptr<BatchVolume> > readVolumes   ( BATCH_QUEUE_CAPACITY );
+	BoundedQueue< std::unique_ptr<BatchVolume> > thinnedVolumes( BATCH_QUEUE_CAPACITY );
+
+	bool readSuccess  = true;
+	bool writeSuccess = true;
+
+	// Read (and threshold) the volumes ahead of the thinning
+	std::thread readerThread( [&]()
+	{
+		for( size_t volumeIdx = 0; volumeIdx < inputFilenames.size(); ++volumeIdx )
+		{
+			std::unique_ptr<BatchVolume> batchVolume( new BatchVolume );
+			batchVolume->inputFilename  = inputFilenames [ volumeIdx ];
+			batchVolume->outputFilename = outputFilenames[ volumeIdx ];
+			batchVolume->valid          = readVolume( batchVolume->volume, batchVolume->inputFilename, _sizeX, _sizeY, _sizeZ, _threshold );
+
+			if( !batchVolume->valid )
+				readSuccess = false;
+
+			readVolumes.push( std::move( batchVolume ) );
+		}
+
+		readVolumes.close();
+	} );
+
+	// Write the volumes behind the thinning
+	std::thread writerThread( [&]()
+	{
+		std::unique_ptr<BatchVolume> batchVolume;
+
+		while( thinnedVolumes.pop( batchVolume ) )
+		{
+			if( !writeVolume( batchVolume->volume, batchVolume->outputFilename ) )
+				writeSuccess = false;
+		}
+	} );
+
+	// Thin the volumes in this thread
+	std::unique_ptr<BatchVolume> batchVolume;
+
+	while( readVolumes.pop( batchVolume ) )
+	{
+		// Skip volumes that could not be read
+		if( !batchVolume->valid )
+			continue;
+
+		std::cout << "Thinning volume \"" << batchVolume->inputFilename << "\" to \"" << batchVolume->outputFilename << "\"" << std::endl;
+
+		batchVolume->volume.performThinning( lookupTable );
+
+		thinnedVolumes.push( std::move( batchVolume ) );
+	}
+
+	thinnedVolumes.close();
+
+	readerThread.join();
+	writerThread.join();
+
+	if( !readSuccess )
+		return -2;
+
+	if( !writeSuccess )
+		return -3;
+
+	return 0;
+}
+
+
+// Thin one input volume with each combination of the given thresholds and lookup tables (a parameter sweep), all in one process.
+// The voxel values are read only once and each lookup table is loaded only once. The combinations are thinned in parallel threads.
+// If _writeDifferences is set, only the result of the first threshold is written for each lookup table, followed by the voxels
+// that differ between the results of consecutive thresholds (one "x y z" line per voxel). Otherwise, each result is written.
+static int sweepParameters( const std::string &_inputVolumeFilename, int _sizeX, int _sizeY, int _sizeZ,
+                            const std::vector<std::string> &_thresholds, const std::vector<std::string> &_lookupTableFilenames,
+                            const std::string &_outputFilenamePrefix, bool _writeDifferences )
+{
+	int numThresholds   = static_cast<int>( _thresholds.size() );
+	int numLookupTables = static_cast<int>( _lookupTableFilenames.size() );
+	int numResults      = numThresholds * numLookupTables;
+
+	// -- Read the voxel values of the input volume once --
+
+	std::cout << "Reading input volume \"" << _inputVolumeFilename << "\"" << std::endl;
+
+	vtkSmartPointer<vtkImageData> imageData;
+
+	if( _inputVolumeFilename.substr( _inputVolumeFilename.length() - 3 ) == "png" )
+		imageData = Volume::readPNGImageData( _inputVolumeFilename, _sizeX, _sizeY, _sizeZ );
+	else
+		imageData = Volume::readRAWImageData( _inputVolumeFilename, _sizeX, _sizeY, _sizeZ );
+
+	// Check the image dimensions once, before any thread is started
+	int dimensions[3] = { 0, 0, 0 };
+	if( imageData )
+		imageData->GetDimensions( dimensions );
+
+	if( (dimensions[0] != _sizeX) ||
+	    (dimensions[1] != _sizeY) ||
+	    (dimensions[2] != _sizeZ) )
+	{
+		std::cerr << "Could not read file \"" << _inputVolumeFilename << "\"." << std::endl;
+		return -2;
+	}
+
+	// -- Read each lookup table once --
+
+	std::vector<LookupTable> lookupTables( numLookupTables );
+	std::vector<std::string> lookupTableNames( numLookupTables );
+
+	for( int lookupTableIdx = 0; lookupTableIdx < numLookupTables; ++lookupTableIdx )
+	{
+		const std::string &lookupTableFilename = _lookupTableFilenames[ lookupTableIdx ];
+
+		std::cout << "Reading lookup table \"" << lookupTableFilename << "\"" << std::endl;
+
+		if( !lookupTables[ lookupTableIdx ].readFile( lookupTableFilename ) )
+			return -1;
+
+		// Name the results after the lookup table filename without directory and suffix
+		std::string name = lookupTableFilename.substr( lookupTableFilename.find_last_of( "/\\" ) + 1 );
+		lookupTableNames[ lookupTableIdx ] = name.substr( 0, name.find_last_of( '.' ) );
+	}
+
+	// Get the output filename of the result for the given lookup table and threshold
+	auto getOutputFilename = [&]( int _lookupTableIdx, int _thresholdIdx, const std::string &_suffix )
+	{
+		return _outputFilenamePrefix + lookupTableNames[ _lookupTableIdx ] + "_" + _thresholds[ _thresholdIdx ] + _suffix;
+	};
+
+	// -- Thin all combinations in parallel --
+
+	// The set voxels of each result, if only the differences between the results are written
+	std::vector< std::vector<long long> > resultVoxelIndices( _writeDifferences ? numResults : 0 );
+
+	std::atomic<int>  nextResultIdx( 0 );
+	std::atomic<bool> success( true );
+
+	auto thinResults = [&]()
+	{
+		// Take the next combination, until all combinations were thinned
+		for( int resultIdx = nextResultIdx++; resultIdx < numResults; resultIdx = nextResultIdx++ )
+		{
+			int lookupTableIdx = resultIdx / numThresholds;
+			int thresholdIdx   = resultIdx % numThresholds;
+
+			// Print the whole line at once, since the threads print concurrently
+			std::ostringstream message;
+			message << "Thinning with lookup table \"" << lookupTableNames[ lookupTableIdx ] << "\" and threshold " << _thresholds[ thresholdIdx ] << "\n";
+			std::cout << message.str() << std::flush;
+
+			Volume volume;
+
+			if( !volume.createFromImageData( imageData, _sizeX, _sizeY, _sizeZ, atof( _thresholds[ thresholdIdx ].c_str() ) ) )
+			{
+				std::cerr << "Could not read file \"" << _inputVolumeFilename << "\"." << std::endl;
+				success = false;
+				return;
+			}
+
+			volume.performThinning( lookupTables[ lookupTableIdx ] );
+
+			// Write the whole result, unless only the differences to the result of the previous threshold are written
+			if( _writeDifferences )
+				volume.getSetVoxelIndices( resultVoxelIndices[ resultIdx ] );
+
+			if( !_writeDifferences || (thresholdIdx == 0) )
+				if( !volume.writeRAWFile( getOutputFilename( lookupTableIdx, thresholdIdx, ".raw" ) ) )
+					success = false;
+		}
+	};
+
+	int numThreads = std::max( 1, std::min( static_cast<int>( std::thread::hardware_concurrency() ), numResults ) );
+
+	std::vector<std::thread> threads;
+	for( int threadIdx = 1; threadIdx < numThreads; ++threadIdx )
+		threads.emplace_back( thinResults );
+
+	thinResults();
+
+	for( auto &thread : threads )
+		thread.join();
+
+	if( !success )
+		return -2;
+
+	// -- Write the differences between the results of consecutive thresholds --
+
+	if( _writeDifferences )
+	{
+		for( int resultIdx = 0; resultIdx < numResults; ++resultIdx )
+		{
+			int lookupTableIdx = resultIdx / numThresholds;
+			int thresholdIdx   = resultIdx % numThresholds;
+
+			if( thresholdIdx == 0 )
+				continue;
+
+			// The voxels that are set in only one of both results
+			std::vector<long long> differentVoxelIndices;
+			std::set_symmetric_difference( resultVoxelIndices[ resultIdx-1 ].begin(), resultVoxelIndices[ resultIdx-1 ].end(),
+			                               resultVoxelIndices[ resultIdx   ].begin(), resultVoxelIndices[ resultIdx   ].end(),
+			                               std::back_inserter( differentVoxelIndices ) );
+
+			std::string outputFilename = getOutputFilename( lookupTableIdx, thresholdIdx, ".txt" );
+
+			std::ofstream ofs( outputFilename );
+			if( !ofs.is_open() )
+			{
+				std::cerr << "Could not open file \"" << outputFilename << "\"." << std::endl;
+				return -3;
+			}
+
+			for( long long voxelIdx : differentVoxelIndices )
+				ofs << (voxelIdx % _sizeX) << " " << (voxelIdx / _sizeX % _sizeY) << " " << (voxelIdx / _sizeX / _sizeY) << "\n";
+		}
+	}
+
+	return 0;
+}
+
 
 // This program reads a lookup table and a three-dimensional volume, thins the volume with the help of the lookup table,
 // interactively displays the original and the thinned volume and writes the thinned result.
@@ -25,6 +404,67 @@ int main( int _numArguments, char *_arguments[] )
 	// Get the program's filename
 	std::string programFilename = _arguments[0];
 
+	// ---- Thin a batch of 2D images, if requested ----
+
+	if( (_numArguments == 9) && (std::string( _arguments[1] ) == "-2d") )
+	{
+		return thinImages( _arguments[2], _arguments[3], atoi( _arguments[4] ), atoi( _arguments[5] ), atoi( _arguments[6] ), atof( _arguments[7] ), _arguments[8] );
+	}
+
+	// ---- Thin a batch of volumes in a pipeline, if requested ----
+
+	// The first and last index may only be omitted for a list file
+	if( (_numArguments == 9) && (std::string( _arguments[1] ) == "-batch") && isListFilename( _arguments[3] ) )
+	{
+		return thinVolumes( _arguments[2], _arguments[3], atoi( _arguments[4] ), atoi( _arguments[5] ), atoi( _arguments[6] ), atof( _arguments[7] ), _arguments[8], 0, -1 );
+	}
+
+	if( (_numArguments == 11) && (std::string( _arguments[1] ) == "-batch") )
+	{
+		return thinVolumes( _arguments[2], _arguments[3], atoi( _arguments[4] ), atoi( _arguments[5] ), atoi( _arguments[6] ), atof( _arguments[7] ), _arguments[8], atoi( _arguments[9] ), atoi( _arguments[10] ) );
+	}
+
+	// ---- Sweep thresholds and lookup tables on one input volume, if requested ----
+
+	if( (_numArguments >= 10) && (std::string( _arguments[1] ) == "-sweep") )
+	{
+		// Only write all results or their differences
+		std::string outputMode = _arguments[8];
+
+		if( (outputMode != "full") && (outputMode != "diff") )
+		{
+			std::cerr << "Unknown output mode \"" << outputMode << "\"." << std::endl;
+			std::cout << "Usage: " << programFilename << " -sweep <Input Volume Filename> <Size in X> <Size in Y> <Size in Z> <Threshold,Threshold,...> <Output Filename Prefix> <full|diff> <Lookup Table Filename> [<Lookup Table Filename> ...]" << std::endl;
+			return -5;
+		}
+
+		// Split the comma separated thresholds
+		std::vector<std::string> thresholds;
+		std::istringstream thresholdStream( _arguments[6] );
+
+		for( std::string threshold; std::getline( thresholdStream, threshold, ',' ); )
+			thresholds.push_back( threshold );
+
+		std::vector<std::string> lookupTableFilenames( _arguments + 9, _arguments + _numArguments );
+
+		return sweepParameters( _arguments[2], atoi( _arguments[3] ), atoi( _arguments[4] ), atoi( _arguments[5] ),
+		                        thresholds, lookupTableFilenames, _arguments[7], outputMode == "diff" );
+	}
+
+	// ---- Get the number of worker processes for the distributed thinning, if requested ----
+
+	int numWorkers = 1;
+
+	if( (_numArguments >= 3) && (std::string( _arguments[1] ) == "-workers") )
+	{
+		numWorkers = atoi( _arguments[2] );
+
+		// Skip the worker parameters. The remaining program parameters are the regular ones.
+		_arguments[2]  = _arguments[0];
+		_arguments    += 2;
+		_numArguments -= 2;
+	}
+
 	// ---- Read or create the lookup table and the input volume ----
 
 	LookupTable lookupTable;
@@ -52,24 +492,18 @@ int main( int _numArguments, char *_arguments[] )
 
 		std::cout << "Reading input volume \"" << inputVolumeFilename << "\"" << std::endl;
 
-		// Check, if the suffix of the input volume filename is "png" (lower case). Read png or raw file(s) accordingly.
-		if( inputVolumeFilename.substr( inputVolumeFilename.length() - 3 ) == "png" )
-		{
-			// Read the input volume from png files
-			if( !volume.readPNGFiles( inputVolumeFilename, sizeX, sizeY, sizeZ, threshold ) )
-				return -2;
-		}
-		else
-		{
-			// Read the input volume from a raw file
-			if( !volume.readRAWFile( inputVolumeFilename, sizeX, sizeY, sizeZ, threshold ) )
-				return -2;
-		}
+		if( !readVolume( volume, inputVolumeFilename, sizeX, sizeY, sizeZ, threshold ) )
+			return -2;
 	}
 	else
 	{
 		// Print the intended usage of this program
 		std::cout << "Usage: " << programFilename << " <Lookup Table Filename> <Input Volume Filename> <Size in X> <Size in Y> <Size in Z> <Threshold> [<Output Volume Filename>]" << std::endl;
+		std::cout << "   or: " << programFilename << " -workers <Number of Worker Processes> <Lookup Table Filename> <Input Volume Filename> <Size in X> <Size in Y> <Size in Z> <Threshold> [<Output Volume Filename>]" << std::endl;
+		std::cout << "   or: " << programFilename << " -2d <Lookup Table Filename> <Input Image Filename Pattern> <Size in X> <Size in Y> <Number of Images> <Threshold> <Output Image Filename Pattern>" << std::endl;
+		std::cout << "   or: " << programFilename << " -sweep <Input Volume Filename> <Size in X> <Size in Y> <Size in Z> <Threshold,Threshold,...> <Output Filename Prefix> <full|diff> <Lookup Table Filename> [<Lookup Table Filename> ...]" << std::endl;
+		std::cout << "   or: " << programFilename << " -batch <Lookup Table Filename> <Input Volume Filename Pattern> <Size in X> <Size in Y> <Size in Z> <Threshold> <Output Volume Filename Pattern> <First Index> <Last Index>" << std::endl;
+		std::cout << "   or: " << programFilename << " -batch <Lookup Table Filename> <Input Volume List Filename> <Size in X> <Size in Y> <Size in Z> <Threshold> <Output Volume Filename Pattern>" << std::endl;
 		std::cout << std::endl;
 
 		// -- Read the default lookup table --
@@ -120,7 +554,15 @@ int main( int _numArguments, char *_arguments[] )
 
 	std::cout << "Thinning volume" << std::endl;
 
-	volume.performThinning( lookupTable );
+	if( numWorkers > 1 )
+	{
+		if( !volume.performDistributedThinning( lookupTable, numWorkers ) )
+			return -4;
+	}
+	else
+	{
+		volume.performThinning( lookupTable );
+	}
 
 	// ---- Write the output volume ----
 
@@ -132,19 +574,8 @@ int main( int _numArguments, char *_arguments[] )
 
 		std::cout << "Writing output volume \"" << outputVolumeFilename << "\"" << std::endl;
 
-		// Check, if the suffix of the output volume filename is "png" (lower case). Write png or raw file(s) accordingly.
-		if( outputVolumeFilename.substr( outputVolumeFilename.length() - 3 ) == "png" )
-		{
-			// Write the output volume to png files
-			if( !volume.writePNGFiles( outputVolumeFilename ) )
-				return -3;
-		}
-		else
-		{
-			// Write the output volume to a raw file
-			if( !volume.writeRAWFile( outputVolumeFilename ) )
-				return -3;
-		}
+		if( !writeVolume( volume, outputVolumeFilename ) )
+			return -3;
 	}
 
 	// ---- Add a copy of the thinned volume to the right renderer ----